@@ -8,84 +8,133 @@
 #include <random>
 #include <fstream>
 #include <sstream>
+#include "Parallel.h"
+#include "Stats.h"
+#include "Intern.h"
+#include "Tasks.h"
+#include "Trace.h"
+#include <unordered_map>
 
 // Forward declaration
 struct Node;
 
 struct FuncParam {
     std::string type;
-    std::string name;
+    Name name;
 };
 
-// Контекст памяти (переменные и функции)
+// Ошибка с именем из скрипта. Сообщение собирается в отдельной функции:
+// его временные строки не занимают место в кадрах стека рекурсивного вычислителя.
+#if defined(__GNUC__)
+#define FOX_NOINLINE __attribute__((noinline))
+#define FOX_FORCEINLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#define FOX_NOINLINE __declspec(noinline)
+#define FOX_FORCEINLINE __forceinline
+#else
+#define FOX_NOINLINE
+#define FOX_FORCEINLINE inline
+#endif
+
+[[noreturn]] FOX_NOINLINE static void nameError(const char* before, Name name, const char* after) {
+    throw std::runtime_error(before + *name + after);
+}
+
+// Контекст памяти (переменные и функции).
+// Ключи - интернированные имена, поэтому поиск идет по указателю, а не по строке.
 struct Context {
     Context* parent = nullptr; // Для глобальных переменных
-    std::map<std::string, std::string> variables;
-    std::map<std::string, std::shared_ptr<Node>> functions; // Храним функции
-    std::map<std::string, std::vector<std::string>> arrays;
+    // Глобальная память только для чтения (функции и массивы) у потоков pmap/preduce
+    const Context* shared = nullptr;
+    std::unordered_map<Name, Str> variables;
+    std::unordered_map<Name, std::shared_ptr<Node>> functions; // Храним функции
+    std::unordered_map<Name, std::vector<Str>> arrays;
 
-    bool exists(const std::string& name) {
+    bool exists(Name name) {
         if (variables.count(name) || arrays.count(name)) return true;
         if (parent) return parent->exists(name);
-        return false;
+        return shared && shared->arrays.count(name);
     }
 
-    std::string getVar(const std::string& name) {
-        if (variables.count(name)) return variables[name];
-        if (parent) return parent->getVar(name);
-        throw std::runtime_error("Runtime Error: Variable '" + name + "' not found!");
+    const Str& getVar(Name name) {
+        size_t depth = 0;
+        for (Context* c = this; c != nullptr; c = c->parent, depth++) {
+            auto it = c->variables.find(name);
+            if (it != c->variables.end()) {
+                FOX_STAT_LOOKUP(depth);
+                return it->second;
+            }
+        }
+        nameError("Runtime Error: Variable '", name, "' not found!");
     }
     
-    std::vector<std::string>& getArray(const std::string& name) {
-        if (arrays.count(name)) return arrays[name];
+    std::vector<Str>& getArray(Name name) {
+        auto it = arrays.find(name);
+        if (it != arrays.end()) return it->second;
         if (parent) return parent->getArray(name);
-        throw std::runtime_error("Runtime Error: Array '" + name + "' not found!");
+        if (shared && shared->arrays.count(name)) {
+            nameError("Runtime Error: Array '", name, "' is read-only inside pmap/preduce!");
+        }
+        nameError("Runtime Error: Array '", name, "' not found!");
+    }
+
+    // Массив для чтения: видит и общую память потоков pmap/preduce
+    const std::vector<Str>& readArray(Name name) const {
+        auto it = arrays.find(name);
+        if (it != arrays.end()) return it->second;
+        if (parent) return parent->readArray(name);
+        if (shared) return shared->readArray(name);
+        nameError("Runtime Error: Array '", name, "' not found!");
     }
 
-    void setVar(const std::string& name, const std::string& val) {
-        if (variables.count(name)) { variables[name] = val; return; }
+    void setVar(Name name, const Str& val) {
+        auto it = variables.find(name);
+        if (it != variables.end()) { it->second = val; return; }
         if (parent) { parent->setVar(name, val); return; }
-        throw std::runtime_error("Error: Variable '" + name + "' not defined!");
+        nameError("Error: Variable '", name, "' not defined!");
     }
 
-    void defineVar(const std::string& name, const std::string& val) {
-        if (variables.count(name)) {
-            throw std::runtime_error("Error: Variable '" + name + "' already defined!");
+    void defineVar(Name name, const Str& val) {
+        if (!variables.emplace(name, val).second) {
+            nameError("Error: Variable '", name, "' already defined!");
         }
-        variables[name] = val;
     }
 
-    void defineGlobal(const std::string& name, const std::string& val) {
+    void defineGlobal(Name name, const Str& val) {
         if (parent) parent->defineGlobal(name, val);
         else defineVar(name, val);
     }
     
-    std::shared_ptr<Node> getFunc(const std::string& name) {
-        if (functions.count(name)) return functions[name];
+    std::shared_ptr<Node> getFunc(Name name) const {
+        auto it = functions.find(name);
+        if (it != functions.end()) return it->second;
         if (parent) return parent->getFunc(name);
+        if (shared) return shared->getFunc(name);
         return nullptr;
     }
     
-    void defineFunc(const std::string& name, std::shared_ptr<Node> body) {
+    void defineFunc(Name name, std::shared_ptr<Node> body) {
         functions[name] = body;
     }
 };
 
 // Специальный тип для RETURN
 struct ReturnValue {
-    std::string value;
+    Str value;
 };
 
-static std::string formatNumber(double val) {
+static Str formatNumber(double val) {
     std::string s = std::to_string(val);
     s.erase(s.find_last_not_of('0') + 1, std::string::npos);
     if (s.back() == '.') s.pop_back();
+    FOX_STAT_STRING(s);
     return s;
 }
 
 struct Node {
+    int line = 0; // строка в исходнике (заполняется для операторов, вызовов и циклов)
     virtual ~Node() = default;
-    virtual std::string eval(Context& ctx) = 0;
+    virtual Str eval(Context& ctx) = 0;
 };
 
 // --- ОСНОВНЫЕ УЗЛЫ ---
@@ -93,193 +142,548 @@ struct Node {
 // Определение функции
 struct FuncDefNode : Node {
     std::string returnType;
-    std::string name;
+    Name name;
     std::vector<FuncParam> params;
     std::shared_ptr<Node> body;
 
     FuncDefNode(std::string rt, std::string n, std::vector<FuncParam> p, std::shared_ptr<Node> b) 
-        : returnType(rt), name(n), params(p), body(b) {}
+        : returnType(rt), name(internName(n)), params(p), body(b) {}
 
     // Eval ничего не делает, функция регистрируется Парсером
-    std::string eval(Context& ctx) override { return ""; }
+    Str eval(Context& ctx) override { FOX_STAT_NODE(FuncDef); return Str(); }
 };
 
 // RETURN - выбрасывает исключение с значением
 struct ReturnNode : Node {
     std::unique_ptr<Node> expr;
     ReturnNode(std::unique_ptr<Node> e) : expr(std::move(e)) {}
-    std::string eval(Context& ctx) override {
-        std::string result = expr ? expr->eval(ctx) : "0";
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Return);
+        Str result = expr ? expr->eval(ctx) : strFalse();
         throw ReturnValue{result}; 
     }
 };
 
+// Выполняет тело функции в новой области видимости поверх root.
+// Встраивается в место вызова: один кадр стека на вызов FoxLang вместо двух.
+FOX_FORCEINLINE static Str invokeFunc(FuncDefNode* funcDef, Context& root, const std::vector<Str>& argValues, int line) {
+    FOX_STAT_COUNT(funcCalls, 1);
+    if (stackExhausted()) nameError("Runtime Error: Stack overflow in '", funcDef->name, "' (recursion too deep)");
+    TraceFuncScope trace(funcDef->name, line);
+    // Создаем локальную область видимости
+    Context funcScope;
+    funcScope.parent = &root;
+
+    for (size_t i = 0; i < funcDef->params.size(); i++) {
+        funcScope.defineVar(funcDef->params[i].name, argValues[i]);
+    }
+
+    try {
+        funcDef->body->eval(funcScope);
+    } catch (const ReturnValue& ret) {
+        return ret.value; // ВОЗВРАЩАЕМ ЗНАЧЕНИЕ В ПЕРЕМЕННУЮ
+    }
+
+    return strFalse();
+}
+
 // ВЫЗОВ ФУНКЦИИ - самое важное для тебя!
 struct FuncCallNode : Node {
-    std::string name;
+    Name name;
     std::vector<std::unique_ptr<Node>> args;
 
     FuncCallNode(std::string n, std::vector<std::unique_ptr<Node>> a) 
-        : name(n), args(std::move(a)) {}
+        : name(internName(n)), args(std::move(a)) {}
 
-    std::string eval(Context& ctx) override {
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(FuncCall);
         auto funcNodeBase = ctx.getFunc(name);
-        if (!funcNodeBase) {
-            throw std::runtime_error("Runtime Error: Function '" + name + "' not found!");
-        }
+        if (!funcNodeBase) nameError("Runtime Error: Function '", name, "' not found!");
         
         FuncDefNode* funcDef = static_cast<FuncDefNode*>(funcNodeBase.get());
         
-        if (args.size() != funcDef->params.size()) {
-            throw std::runtime_error("Args count mismatch for '" + name + "'");
-        }
+        if (args.size() != funcDef->params.size()) nameError("Args count mismatch for '", name, "'");
 
-        std::vector<std::string> argValues;
+        std::vector<Str> argValues;
         for (auto& arg : args) argValues.push_back(arg->eval(ctx));
 
         // Находим глобальный контекст
         Context* root = &ctx;
         while (root->parent != nullptr) root = root->parent;
-        
-        // Создаем локальную область видимости
-        Context funcScope;
-        funcScope.parent = root; 
 
-        for (size_t i = 0; i < funcDef->params.size(); i++) {
-            funcScope.defineVar(funcDef->params[i].name, argValues[i]);
-        }
-
-        try {
-            funcDef->body->eval(funcScope);
-        } catch (const ReturnValue& ret) {
-            return ret.value; // ВОЗВРАЩАЕМ ЗНАЧЕНИЕ В ПЕРЕМЕННУЮ
-        }
-
-        return "0";
+        return invokeFunc(funcDef, *root, argValues, line);
     }
 };
 
+// Литералы интернируются при разборе: eval отдает указатель, без копии строки
 struct NumberNode : Node {
-    std::string val;
-    NumberNode(std::string v) : val(v) {}
-    std::string eval(Context& ctx) override { return val; }
+    Str val;
+    NumberNode(std::string v) : val(intern(v)) {}
+    Str eval(Context& ctx) override { FOX_STAT_NODE(Number); return val; }
 };
 struct StringNode : Node {
-    std::string val;
-    StringNode(std::string v) : val(v) {}
-    std::string eval(Context& ctx) override { return val; }
+    Str val;
+    StringNode(std::string v) : val(intern(v)) {}
+    Str eval(Context& ctx) override { FOX_STAT_NODE(String); return val; }
 };
 struct VarAccessNode : Node {
-    std::string name;
-    VarAccessNode(std::string n) : name(n) {}
-    std::string eval(Context& ctx) override { return ctx.getVar(name); }
+    Name name;
+    VarAccessNode(std::string n) : name(internName(n)) {}
+    Str eval(Context& ctx) override { FOX_STAT_NODE(VarAccess); return ctx.getVar(name); }
 };
 struct GlobalVarDeclNode : Node {
-    std::string type, name; std::unique_ptr<Node> expr;
-    GlobalVarDeclNode(std::string t, std::string n, std::unique_ptr<Node> e) : type(t), name(n), expr(std::move(e)) {}
-    std::string eval(Context& ctx) override {
+    std::string type; Name name; std::unique_ptr<Node> expr;
+    GlobalVarDeclNode(std::string t, std::string n, std::unique_ptr<Node> e) : type(t), name(internName(n)), expr(std::move(e)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(GlobalVarDecl);
         Context* root = &ctx;
         while (root->parent != nullptr) root = root->parent;
         root->defineVar(name, expr->eval(ctx)); 
-        return "";
+        return Str();
     }
 };
 struct VarDeclNode : Node {
-    std::string type, name; std::unique_ptr<Node> expr;
-    VarDeclNode(std::string t, std::string n, std::unique_ptr<Node> e) : type(t), name(n), expr(std::move(e)) {}
-    std::string eval(Context& ctx) override {
+    std::string type; Name name; std::unique_ptr<Node> expr;
+    VarDeclNode(std::string t, std::string n, std::unique_ptr<Node> e) : type(t), name(internName(n)), expr(std::move(e)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(VarDecl);
         // Здесь expr->eval(ctx) может быть FuncCallNode, который вернет результат!
         ctx.defineVar(name, expr->eval(ctx));
-        return "";
+        return Str();
     }
 };
 struct AssignNode : Node {
-    std::string name; std::unique_ptr<Node> expr;
-    AssignNode(std::string n, std::unique_ptr<Node> e) : name(n), expr(std::move(e)) {}
-    std::string eval(Context& ctx) override {
+    Name name; std::unique_ptr<Node> expr;
+    AssignNode(std::string n, std::unique_ptr<Node> e) : name(internName(n)), expr(std::move(e)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Assign);
         ctx.setVar(name, expr->eval(ctx));
-        return "";
+        return Str();
     }
 };
+// Склейка строк вынесена из BinOpNode::eval, чтобы не увеличивать его кадр стека
+FOX_NOINLINE static Str concat(const std::string& a, const std::string& b) {
+    std::string r = a + b;
+    FOX_STAT_STRING(r);
+    return Str(std::move(r));
+}
+
 struct BinOpNode : Node {
     char op; std::unique_ptr<Node> left, right;
     BinOpNode(char o, std::unique_ptr<Node> l, std::unique_ptr<Node> r) : op(o), left(std::move(l)), right(std::move(r)) {}
-    std::string eval(Context& ctx) override {
-        std::string lStr = left->eval(ctx); std::string rStr = right->eval(ctx);
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(BinOp);
+        Str lVal = left->eval(ctx); Str rVal = right->eval(ctx);
+        const std::string& lStr = lVal; const std::string& rStr = rVal;
         bool isStr = (lStr.find_first_not_of("0123456789.-") != std::string::npos) || (rStr.find_first_not_of("0123456789.-") != std::string::npos);
-        if (op == '+' && isStr) return lStr + rStr;
+        if (op == '+' && isStr) return concat(lStr, rStr);
         double l = std::stod(lStr); double r = std::stod(rStr);
         if (op == '+') return formatNumber(l+r);
         if (op == '-') return formatNumber(l-r);
         if (op == '*') return formatNumber(l*r);
         if (op == '/') return formatNumber(r!=0 ? l/r : 0);
         if (op == '%') return formatNumber((int)l % (int)r);
-        return "0";
+        return strFalse();
     }
 };
 struct CompareNode : Node {
     std::string op; std::unique_ptr<Node> left, right;
     CompareNode(std::string o, std::unique_ptr<Node> l, std::unique_ptr<Node> r) : op(o), left(std::move(l)), right(std::move(r)) {}
-    std::string eval(Context& ctx) override {
-        double l = std::stod(left->eval(ctx)); double r = std::stod(right->eval(ctx));
-        if (op == "==") return (std::abs(l - r) < 0.001) ? "1" : "0";
-        if (op == "!=") return (std::abs(l - r) > 0.001) ? "1" : "0";
-        if (op == "<") return (l < r) ? "1" : "0";
-        if (op == ">") return (l > r) ? "1" : "0";
-        return "0";
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Compare);
+        double l = std::stod(left->eval(ctx).str()); double r = std::stod(right->eval(ctx).str());
+        if (op == "==") return (std::abs(l - r) < 0.001) ? strTrue() : strFalse();
+        if (op == "!=") return (std::abs(l - r) > 0.001) ? strTrue() : strFalse();
+        if (op == "<") return (l < r) ? strTrue() : strFalse();
+        if (op == ">") return (l > r) ? strTrue() : strFalse();
+        return strFalse();
     }
 };
 struct IfNode : Node {
     std::unique_ptr<Node> cond, thenB, elseB;
     IfNode(std::unique_ptr<Node> c, std::unique_ptr<Node> t, std::unique_ptr<Node> e) : cond(std::move(c)), thenB(std::move(t)), elseB(std::move(e)) {}
-    std::string eval(Context& ctx) override {
-        if (cond->eval(ctx) == "1") thenB->eval(ctx);
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(If);
+        if (cond->eval(ctx) == strTrue()) thenB->eval(ctx);
         else if (elseB) elseB->eval(ctx);
-        return "";
+        return Str();
     }
 };
 struct WhileNode : Node {
     std::unique_ptr<Node> cond, body;
     WhileNode(std::unique_ptr<Node> c, std::unique_ptr<Node> b) : cond(std::move(c)), body(std::move(b)) {}
-    std::string eval(Context& ctx) override {
-        while (cond->eval(ctx) == "1") body->eval(ctx);
-        return "";
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(While);
+        if (!traceEnabled) {
+            while (cond->eval(ctx) == strTrue()) body->eval(ctx);
+            return Str();
+        }
+        // С трассировкой: число итераций раз в TRACE_LOOP_SAMPLE и при выходе
+        uint64_t iterations = 0;
+        try {
+            while (cond->eval(ctx) == strTrue()) {
+                body->eval(ctx);
+                if (++iterations % TRACE_LOOP_SAMPLE == 0) FOX_TRACE(Loop, nullptr, line, iterations);
+            }
+        } catch (...) { // return из цикла или ошибка
+            FOX_TRACE(Loop, nullptr, line, iterations);
+            throw;
+        }
+        FOX_TRACE(Loop, nullptr, line, iterations);
+        return Str();
     }
 };
 struct BlockNode : Node {
     std::vector<std::unique_ptr<Node>> stmts;
-    std::string eval(Context& ctx) override {
-        for(auto& s : stmts) s->eval(ctx);
-        return "";
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Block);
+        for(auto& s : stmts) { FOX_TRACE_LINE(s); s->eval(ctx); }
+        return Str();
     }
 };
 struct PrintNode : Node {
     std::unique_ptr<Node> expr;
     PrintNode(std::unique_ptr<Node> e) : expr(std::move(e)) {}
-    std::string eval(Context& ctx) override { std::cout << expr->eval(ctx) << std::endl; return ""; }
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Print);
+        Str value = expr->eval(ctx);
+        // Из pmap/preduce печатают сразу несколько потоков: строки выводятся по одной
+        static std::mutex mtx;
+        std::lock_guard<std::mutex> lock(mtx);
+        std::cout << value << std::endl;
+        return Str();
+    }
 };
 struct InputNode : Node {
-    std::string eval(Context& ctx) override { std::string b; std::getline(std::cin, b); return b; }
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Input);
+        std::string b = Scheduler::instance().readLine(); // другие задачи работают, пока ждем строку
+        FOX_STAT_STRING(b);
+        return Str(std::move(b));
+    }
 };
 struct ArrayDeclNode : Node {
-    std::string name; std::unique_ptr<Node> size;
-    ArrayDeclNode(std::string n, std::unique_ptr<Node> s) : name(n), size(std::move(s)) {}
-    std::string eval(Context& ctx) override {
-        ctx.arrays[name] = std::vector<std::string>(std::stoi(size->eval(ctx)), "0");
-        return "";
+    Name name; std::unique_ptr<Node> size;
+    ArrayDeclNode(std::string n, std::unique_ptr<Node> s) : name(internName(n)), size(std::move(s)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(ArrayDecl);
+        ctx.arrays[name] = std::vector<Str>(std::stoi(size->eval(ctx).str()), strFalse());
+        FOX_STAT_COUNT(arrayElements, ctx.arrays[name].size());
+        return Str();
     }
 };
 struct ArraySetNode : Node {
-    std::string name; std::unique_ptr<Node> idx, val;
-    ArraySetNode(std::string n, std::unique_ptr<Node> i, std::unique_ptr<Node> v) : name(n), idx(std::move(i)), val(std::move(v)) {}
-    std::string eval(Context& ctx) override {
-        auto& arr = ctx.getArray(name); arr[std::stoi(idx->eval(ctx))] = val->eval(ctx); return "";
+    Name name; std::unique_ptr<Node> idx, val;
+    ArraySetNode(std::string n, std::unique_ptr<Node> i, std::unique_ptr<Node> v) : name(internName(n)), idx(std::move(i)), val(std::move(v)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(ArraySet);
+        auto& arr = ctx.getArray(name); arr[std::stoi(idx->eval(ctx).str())] = val->eval(ctx); return Str();
     }
 };
 struct ArrayGetNode : Node {
-    std::string name; std::unique_ptr<Node> idx;
-    ArrayGetNode(std::string n, std::unique_ptr<Node> i) : name(n), idx(std::move(i)) {}
-    std::string eval(Context& ctx) override { return ctx.getArray(name)[std::stoi(idx->eval(ctx))]; }
+    Name name; std::unique_ptr<Node> idx;
+    ArrayGetNode(std::string n, std::unique_ptr<Node> i) : name(internName(n)), idx(std::move(i)) {}
+    Str eval(Context& ctx) override { FOX_STAT_NODE(ArrayGet); return ctx.readArray(name)[std::stoi(idx->eval(ctx).str())]; }
+};
+
+// --- ПАРАЛЛЕЛЬНЫЕ ВСТРОЕННЫЕ ФУНКЦИИ ---
+
+// Ищет функцию для pmap/preduce и проверяет число параметров
+static FuncDefNode* findParallelFunc(Context& ctx, Name name, size_t minArgs, size_t maxArgs) {
+    auto funcNodeBase = ctx.getFunc(name);
+    if (!funcNodeBase) {
+        nameError("Runtime Error: Function '", name, "' not found!");
+    }
+    FuncDefNode* funcDef = static_cast<FuncDefNode*>(funcNodeBase.get());
+    if (funcDef->params.size() < minArgs || funcDef->params.size() > maxArgs) {
+        nameError("Args count mismatch for '", name, "'");
+    }
+    return funcDef;
+}
+
+// Память рабочего потока. Глобальные переменные копируются (это указатели на
+// общие строки): функция может их менять, но после pmap/preduce изменения
+// теряются. Функции и глобальные массивы не копируются, а читаются из общей
+// памяти через shared - пока идет pmap/preduce, ее никто не меняет, а запись
+// в глобальный массив из функции - ошибка. Свои массивы функция создавать может.
+static std::shared_ptr<Context> workerFrame(Context& ctx) {
+    Context* root = &ctx;
+    while (root->parent != nullptr) root = root->parent;
+    auto frame = std::make_shared<Context>();
+    frame->variables = root->variables;
+    frame->shared = root;
+    return frame;
+}
+
+// pmap(dst, src, func); — dst[i] = func(src[i]) (или func(src[i], i))
+struct ParallelMapNode : Node {
+    Name dst, src, func;
+    ParallelMapNode(std::string d, std::string s, std::string f) : dst(internName(d)), src(internName(s)), func(internName(f)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(ParallelMap);
+        FuncDefNode* funcDef = findParallelFunc(ctx, func, 1, 2);
+        bool withIndex = funcDef->params.size() == 2;
+
+        // Результат собирается отдельно и попадает в dst после всех потоков,
+        // так что функция может читать и src, и dst (старое содержимое)
+        const std::vector<Str>& in = ctx.readArray(src);
+        std::vector<Str> out(in.size());
+        FOX_STAT_COUNT(arrayElements, out.size());
+
+        ChunkPlan plan = planChunks(in.size());
+        parallelChunks(plan, [&]() -> std::function<void(size_t, size_t, size_t)> {
+            auto local = workerFrame(ctx);
+            return [&, local](size_t begin, size_t end, size_t) {
+                std::vector<Str> argv(funcDef->params.size());
+                for (size_t i = begin; i < end; i++) {
+                    argv[0] = in[i];
+                    if (withIndex) argv[1] = std::to_string(i);
+                    out[i] = invokeFunc(funcDef, *local, argv, line);
+                }
+            };
+        });
+
+        if (!ctx.exists(dst)) ctx.arrays[dst] = {};
+        ctx.getArray(dst) = std::move(out);
+        return Str();
+    }
 };
-struct IncludeNode : Node { std::string eval(Context& ctx) override { return ""; } };
-struct FoxNode : Node { std::string eval(Context& ctx) override { std::cout << "FoxLang" << std::endl; return ""; } };
\ No newline at end of file
+
+// psum(arr) — сумма элементов массива
+struct ParallelSumNode : Node {
+    Name name;
+    ParallelSumNode(std::string n) : name(internName(n)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(ParallelSum);
+        const std::vector<Str>& arr = ctx.readArray(name);
+        // Один разбор числа на элемент: это дешевая операция, как sort
+        ChunkPlan plan = planChunks(arr.size(), PARALLEL_MIN_CHEAP);
+        std::vector<double> partial(plan.count, 0);
+        parallelChunks(plan, [&]() -> std::function<void(size_t, size_t, size_t)> {
+            return [&](size_t begin, size_t end, size_t c) {
+                double sum = 0;
+                for (size_t i = begin; i < end; i++) sum += std::stod(arr[i].str());
+                partial[c] = sum;
+            };
+        });
+        // Складываем куски по порядку, чтобы результат не зависел от потоков
+        double total = 0;
+        for (double p : partial) total += p;
+        return formatNumber(total);
+    }
+};
+
+// preduce(arr, func, init) — свертка func(acc, x). func должна быть
+// ассоциативной: куски сворачиваются независимо, затем результаты по порядку.
+struct ParallelReduceNode : Node {
+    Name name, func; std::unique_ptr<Node> init;
+    ParallelReduceNode(std::string n, std::string f, std::unique_ptr<Node> i) : name(internName(n)), func(internName(f)), init(std::move(i)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(ParallelReduce);
+        FuncDefNode* funcDef = findParallelFunc(ctx, func, 2, 2);
+        Str acc = init->eval(ctx);
+        const std::vector<Str>& arr = ctx.readArray(name);
+
+        ChunkPlan plan = planChunks(arr.size());
+        std::vector<Str> partial(plan.count);
+        parallelChunks(plan, [&]() -> std::function<void(size_t, size_t, size_t)> {
+            auto local = workerFrame(ctx);
+            return [&, local](size_t begin, size_t end, size_t c) {
+                Str chunkAcc = arr[begin];
+                for (size_t i = begin + 1; i < end; i++) {
+                    chunkAcc = invokeFunc(funcDef, *local, {chunkAcc, arr[i]}, line);
+                }
+                partial[c] = chunkAcc;
+            };
+        });
+
+        Context* root = &ctx;
+        while (root->parent != nullptr) root = root->parent;
+        for (auto& p : partial) acc = invokeFunc(funcDef, *root, {acc, p}, line);
+        return acc;
+    }
+};
+
+// --- ВСТРОЕННЫЕ ФУНКЦИИ ДЛЯ МАССИВОВ И СТРОК ---
+
+static double toNumber(const Str& v) {
+    try { return std::stod(v.str()); }
+    catch (const std::exception&) {
+        throw std::runtime_error("Runtime Error: '" + v.str() + "' is not a number!");
+    }
+}
+
+// sort(arr); — по возрастанию как числа, sortstr(arr); — как строки
+struct SortNode : Node {
+    Name name; bool numeric;
+    SortNode(std::string n, bool num) : name(internName(n)), numeric(num) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Sort);
+        std::vector<Str>& arr = ctx.getArray(name);
+        if (!numeric) {
+            parallelSort(arr, [](const Str& a, const Str& b) { return a.str() < b.str(); });
+            return Str();
+        }
+
+        // Числа разбираются один раз, а не при каждом сравнении
+        struct Keyed { double key; Str val; };
+        std::vector<Keyed> keyed(arr.size());
+        ChunkPlan plan = planChunks(arr.size(), PARALLEL_MIN_CHEAP);
+        parallelChunks(plan, [&]() -> std::function<void(size_t, size_t, size_t)> {
+            return [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin; i < end; i++) keyed[i] = {toNumber(arr[i]), arr[i]};
+            };
+        });
+        parallelSort(keyed, [](const Keyed& a, const Keyed& b) { return a.key < b.key; });
+        for (size_t i = 0; i < arr.size(); i++) arr[i] = std::move(keyed[i].val);
+        return Str();
+    }
+};
+
+// bsearch(arr, value) — индекс числа в отсортированном (sort) массиве или -1
+struct BinarySearchNode : Node {
+    Name name; std::unique_ptr<Node> value;
+    BinarySearchNode(std::string n, std::unique_ptr<Node> v) : name(internName(n)), value(std::move(v)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(BinarySearch);
+        double key = toNumber(value->eval(ctx));
+        const std::vector<Str>& arr = ctx.readArray(name);
+        size_t lo = 0, hi = arr.size();
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (toNumber(arr[mid]) < key) lo = mid + 1; else hi = mid;
+        }
+        if (lo < arr.size() && toNumber(arr[lo]) == key) return formatNumber((double)lo);
+        return formatNumber(-1);
+    }
+};
+
+// indexof(arr, value) — индекс первого элемента, равного value (как строка), или -1
+struct IndexOfNode : Node {
+    Name name; std::unique_ptr<Node> value;
+    IndexOfNode(std::string n, std::unique_ptr<Node> v) : name(internName(n)), value(std::move(v)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(IndexOf);
+        Str needle = value->eval(ctx);
+        const std::vector<Str>& arr = ctx.readArray(name);
+
+        // Куски смотрят параллельно; кусок за уже найденным индексом пропускается
+        std::atomic<size_t> found{arr.size()};
+        ChunkPlan plan = planChunks(arr.size(), PARALLEL_MIN_CHEAP);
+        parallelChunks(plan, [&]() -> std::function<void(size_t, size_t, size_t)> {
+            return [&](size_t begin, size_t end, size_t) {
+                for (size_t i = begin; i < end && i < found.load(std::memory_order_relaxed); i++) {
+                    if (arr[i] == needle) {
+                        size_t prev = found.load();
+                        while (i < prev && !found.compare_exchange_weak(prev, i)) {}
+                        return;
+                    }
+                }
+            };
+        });
+        size_t idx = found.load();
+        return formatNumber(idx < arr.size() ? (double)idx : -1);
+    }
+};
+
+// split(dst, str, sep); — разбивает строку в массив dst (пустой sep - по символам)
+struct SplitNode : Node {
+    Name dst; std::unique_ptr<Node> str, sep;
+    SplitNode(std::string d, std::unique_ptr<Node> s, std::unique_ptr<Node> p) : dst(internName(d)), str(std::move(s)), sep(std::move(p)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Split);
+        Str textVal = str->eval(ctx); Str sepVal = sep->eval(ctx);
+        const std::string& text = textVal; const std::string& delim = sepVal;
+
+        std::vector<Str> parts;
+        if (delim.empty()) {
+            for (char c : text) parts.push_back(intern(std::string(1, c)));
+        } else {
+            size_t start = 0, at;
+            while ((at = text.find(delim, start)) != std::string::npos) {
+                parts.push_back(Str(text.substr(start, at - start)));
+                start = at + delim.size();
+            }
+            parts.push_back(Str(text.substr(start)));
+        }
+
+        FOX_STAT_COUNT(arrayElements, parts.size());
+        if (!ctx.exists(dst)) ctx.arrays[dst] = {};
+        ctx.getArray(dst) = std::move(parts);
+        return Str();
+    }
+};
+
+// join(arr, sep) — склеивает элементы массива через sep
+struct JoinNode : Node {
+    Name name; std::unique_ptr<Node> sep;
+    JoinNode(std::string n, std::unique_ptr<Node> s) : name(internName(n)), sep(std::move(s)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Join);
+        Str sepVal = sep->eval(ctx);
+        const std::string& delim = sepVal;
+        const std::vector<Str>& arr = ctx.readArray(name);
+
+        // Один буфер нужного размера вместо цепочки конкатенаций
+        size_t total = arr.empty() ? 0 : delim.size() * (arr.size() - 1);
+        for (auto& v : arr) total += v.size();
+        std::string out;
+        out.reserve(total);
+        for (size_t i = 0; i < arr.size(); i++) {
+            if (i) out += delim;
+            out += arr[i].str();
+        }
+        FOX_STAT_STRING(out);
+        return Str(std::move(out));
+    }
+};
+
+// --- ЗАДАЧИ (кооперативная многозадачность) ---
+
+// spawn(func, args...); — запускает func отдельной задачей
+struct SpawnNode : Node {
+    Name name;
+    std::vector<std::unique_ptr<Node>> args;
+    SpawnNode(std::string n, std::vector<std::unique_ptr<Node>> a) : name(internName(n)), args(std::move(a)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Spawn);
+        auto funcNodeBase = ctx.getFunc(name);
+        if (!funcNodeBase) {
+            nameError("Runtime Error: Function '", name, "' not found!");
+        }
+        FuncDefNode* funcDef = static_cast<FuncDefNode*>(funcNodeBase.get());
+        if (args.size() != funcDef->params.size()) {
+            nameError("Args count mismatch for '", name, "'");
+        }
+
+        // Аргументы вычисляются сразу, в момент запуска
+        std::vector<Str> argValues;
+        for (auto& arg : args) argValues.push_back(arg->eval(ctx));
+
+        Context* root = &ctx;
+        while (root->parent != nullptr) root = root->parent;
+
+        // funcNodeBase держит функцию живой, пока задача не закончится
+        int callLine = line;
+        Scheduler::instance().spawn([funcNodeBase, funcDef, root, argValues, callLine] {
+            invokeFunc(funcDef, *root, argValues, callLine);
+        });
+        return Str();
+    }
+};
+struct YieldNode : Node {
+    Str eval(Context& ctx) override { FOX_STAT_NODE(Yield); Scheduler::instance().yield(); return Str(); }
+};
+// sleep(ms); — спит только текущая задача
+struct SleepNode : Node {
+    std::unique_ptr<Node> ms;
+    SleepNode(std::unique_ptr<Node> m) : ms(std::move(m)) {}
+    Str eval(Context& ctx) override {
+        FOX_STAT_NODE(Sleep);
+        Scheduler::instance().sleepFor(std::stod(ms->eval(ctx).str()));
+        return Str();
+    }
+};
+
+struct IncludeNode : Node { Str eval(Context& ctx) override { FOX_STAT_NODE(Include); return Str(); } };
+struct FoxNode : Node { Str eval(Context& ctx) override { FOX_STAT_NODE(Fox); std::cout << "FoxLang" << std::endl; return Str(); } };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <ostream>
+
+// Неизменяемая строка с общим владением: копирование - это копия указателя
+// (и счетчика ссылок), а не memcpy содержимого.
+class Str {
+    // Признак интернирования лежит рядом со строкой: Str остается размером
+    // с указатель и счетчик ссылок
+    struct Data {
+        std::string s;
+        bool interned;
+    };
+    std::shared_ptr<const Data> ptr;
+
+    Str(std::string s, bool interned) : ptr(std::make_shared<const Data>(Data{std::move(s), interned})) {}
+    friend Str intern(const std::string& s);
+
+public:
+    Str();
+    Str(std::string s) : Str(std::move(s), false) {}
+    Str(const char* s) : Str(std::string(s)) {}
+
+    const std::string& str() const { return ptr->s; }
+    operator const std::string&() const { return ptr->s; }
+    size_t size() const { return ptr->s.size(); }
+    bool interned() const { return ptr->interned; }
+
+    // Две интернированные строки равны только если это один указатель,
+    // остальные сравниваются по содержимому
+    bool operator==(const Str& o) const {
+        if (ptr == o.ptr) return true;
+        if (ptr->interned && o.ptr->interned) return false;
+        return ptr->s == o.ptr->s;
+    }
+    bool operator!=(const Str& o) const { return !(*this == o); }
+    bool sameAs(const Str& o) const { return ptr == o.ptr; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Str& s) { return out << s.str(); }
+
+// Глобальная таблица интернирования для литералов и идентификаторов.
+// Одинаковые строки из скрипта и всех его include хранятся один раз.
+// Записи живут до конца программы.
+inline Str intern(const std::string& s) {
+    static std::mutex mtx;
+    static std::unordered_map<std::string, Str>* table = new std::unordered_map<std::string, Str>();
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = table->find(s);
+    if (it != table->end()) return it->second;
+    Str str(s, true);
+    table->emplace(s, str);
+    return str;
+}
+
+inline Str::Str() {
+    static const Str empty = intern("");
+    *this = empty;
+}
+
+// Имя (переменной, функции, массива) - указатель на интернированную строку.
+// Одинаковые имена дают один и тот же указатель, поэтому Context ищет по нему.
+using Name = const std::string*;
+
+inline Name internName(const std::string& s) { return &intern(s).str(); }
+
+// Часто используемые константы: результат сравнения и пустое значение
+inline const Str& strTrue() { static const Str s = intern("1"); return s; }
+inline const Str& strFalse() { static const Str s = intern("0"); return s; }
@@ -1,10 +1,12 @@
 #include "Lexer.h"
+#include "Stats.h"
 #include <cctype>
 #include <iostream>
 
 Lexer::Lexer(std::string src) : source(src) {}
 
 std::vector<Token> Lexer::tokenize() {
+    FOX_STAT_PHASE(Lexer);
     std::vector<Token> tokens;
     while (pos < source.length()) {
         char current = source[pos];
@@ -59,6 +61,18 @@ std::vector<Token> Lexer::tokenize() {
             else if (id == "include") tokens.push_back({TokenType::INCLUDE, id, line});
             else if (id == "return") tokens.push_back({TokenType::RETURN, id, line});
             else if (id == "global") tokens.push_back({TokenType::GLOBAL, id, line});
+            else if (id == "pmap") tokens.push_back({TokenType::PMAP, id, line});
+            else if (id == "psum") tokens.push_back({TokenType::PSUM, id, line});
+            else if (id == "preduce") tokens.push_back({TokenType::PREDUCE, id, line});
+            else if (id == "spawn") tokens.push_back({TokenType::SPAWN, id, line});
+            else if (id == "yield") tokens.push_back({TokenType::YIELD, id, line});
+            else if (id == "sleep") tokens.push_back({TokenType::SLEEP, id, line});
+            else if (id == "sort") tokens.push_back({TokenType::SORT, id, line});
+            else if (id == "sortstr") tokens.push_back({TokenType::SORTSTR, id, line});
+            else if (id == "bsearch") tokens.push_back({TokenType::BSEARCH, id, line});
+            else if (id == "indexof") tokens.push_back({TokenType::INDEXOF, id, line});
+            else if (id == "split") tokens.push_back({TokenType::SPLIT, id, line});
+            else if (id == "join") tokens.push_back({TokenType::JOIN, id, line});
             else tokens.push_back({TokenType::IDENTIFIER, id, line});
         } 
         else {
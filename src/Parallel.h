@@ -0,0 +1,193 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+#include "Trace.h"
+
+// Меньше этого количества элементов параллелить нет смысла:
+// копирование памяти для потоков обойдется дороже самой работы
+static const size_t PARALLEL_MIN_ITEMS = 64;
+
+// Порог для дешевых операций над элементами (сортировка, разбор чисел, поиск):
+// элемент обрабатывается за наносекунды, и передача работы потокам пула
+// окупается только на больших массивах
+static const size_t PARALLEL_MIN_CHEAP = 32768;
+
+// Пул рабочих потоков для pmap/psum/preduce.
+// Создается один раз при первом обращении и живет до конца программы.
+class ThreadPool {
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    ThreadPool() {
+        size_t n = std::thread::hardware_concurrency();
+        if (n < 2) n = 2;
+        for (size_t i = 0; i + 1 < n; i++) {
+            workers.emplace_back([this] { loop(); });
+        }
+    }
+
+    void loop() {
+        insideWorker() = true;
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+public:
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers) w.join();
+    }
+
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    // true внутри параллельной работы (в потоке пула или в вызывающем потоке,
+    // пока он выполняет свою часть): вложенный pmap выполняется последовательно,
+    // иначе потоки пула будут ждать сами себя
+    static bool& insideWorker() {
+        thread_local bool flag = false;
+        return flag;
+    }
+
+    // Вызывающий поток + рабочие потоки пула
+    size_t threadCount() const { return workers.size() + 1; }
+
+    // Запускает job в threads потоках (включая вызывающий) и ждет,
+    // пока все закончат. Первое исключение из job пробрасывается наружу.
+    void run(size_t threads, const std::function<void()>& job) {
+        threads = std::max<size_t>(1, std::min(threads, threadCount()));
+        if (threads == 1 || insideWorker()) { job(); return; }
+
+        std::mutex doneMtx;
+        std::condition_variable doneCv;
+        size_t pending = threads - 1;
+        std::exception_ptr error;
+
+        auto wrapped = [&] {
+            try { job(); }
+            catch (...) {
+                traceCurrentError();
+                std::lock_guard<std::mutex> lock(doneMtx);
+                if (!error) error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(doneMtx);
+            if (--pending == 0) doneCv.notify_one();
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (size_t i = 0; i + 1 < threads; i++) tasks.push_back(wrapped);
+        }
+        cv.notify_all();
+
+        // Вызывающий поток тоже работает, а не просто ждет
+        insideWorker() = true;
+        try { job(); }
+        catch (...) {
+            traceCurrentError();
+            std::lock_guard<std::mutex> lock(doneMtx);
+            if (!error) error = std::current_exception();
+        }
+        insideWorker() = false;
+
+        std::unique_lock<std::mutex> lock(doneMtx);
+        doneCv.wait(lock, [&] { return pending == 0; });
+        if (error) std::rethrow_exception(error);
+    }
+};
+
+// Разбиение [0, n) на куски: несколько кусков на поток,
+// чтобы выровнять нагрузку при разной цене элементов
+struct ChunkPlan {
+    size_t n = 0, size = 1, count = 0, threads = 1;
+};
+
+static ChunkPlan planChunks(size_t n, size_t minItems = PARALLEL_MIN_ITEMS) {
+    ChunkPlan plan;
+    plan.n = n;
+    plan.threads = (n < minItems) ? 1 : ThreadPool::instance().threadCount();
+    plan.size = std::max<size_t>(1, n / (plan.threads * 8));
+    plan.count = (n + plan.size - 1) / plan.size;
+    plan.threads = std::max<size_t>(1, std::min(plan.threads, plan.count));
+    return plan;
+}
+
+// Раздает куски потокам через атомарный счетчик.
+// makeWorker вызывается один раз в каждом потоке и возвращает обработчик
+// куска (begin, end, chunkIndex) — так у каждого потока свое состояние.
+static void parallelChunks(const ChunkPlan& plan,
+        const std::function<std::function<void(size_t, size_t, size_t)>()>& makeWorker) {
+    std::atomic<size_t> next{0};
+    ThreadPool::instance().run(plan.threads, [&] {
+        auto work = makeWorker();
+        while (true) {
+            size_t c = next.fetch_add(1);
+            if (c >= plan.count) break;
+            size_t begin = c * plan.size;
+            try {
+                work(begin, std::min(plan.n, begin + plan.size), c);
+            } catch (...) {
+                next = plan.count; // остальные потоки больше не берут куски
+                throw;
+            }
+        }
+    });
+}
+
+// Сортировка: куски сортируются параллельно, затем сливаются попарно
+// (слияния одного прохода тоже идут параллельно)
+template <class T, class Compare>
+static void parallelSort(std::vector<T>& v, Compare cmp) {
+    ChunkPlan plan = planChunks(v.size(), PARALLEL_MIN_CHEAP);
+    if (plan.threads == 1) { std::sort(v.begin(), v.end(), cmp); return; }
+
+    size_t parts = plan.threads;
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t i = 0; i <= parts; i++) bounds[i] = v.size() * i / parts;
+
+    std::atomic<size_t> next{0};
+    ThreadPool::instance().run(parts, [&] {
+        for (size_t p = next.fetch_add(1); p < parts; p = next.fetch_add(1)) {
+            std::sort(v.begin() + bounds[p], v.begin() + bounds[p + 1], cmp);
+        }
+    });
+
+    for (size_t width = 1; width < parts; width *= 2) {
+        size_t pairs = (parts + 2 * width - 1) / (2 * width);
+        std::atomic<size_t> nextPair{0};
+        ThreadPool::instance().run(pairs, [&] {
+            for (size_t p = nextPair.fetch_add(1); p < pairs; p = nextPair.fetch_add(1)) {
+                size_t lo = p * 2 * width;
+                size_t mid = std::min(lo + width, parts);
+                size_t hi = std::min(lo + 2 * width, parts);
+                if (mid == hi) continue;
+                std::inplace_merge(v.begin() + bounds[lo], v.begin() + bounds[mid], v.begin() + bounds[hi], cmp);
+            }
+        });
+    }
+}
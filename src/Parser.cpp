@@ -41,6 +41,7 @@ std::unique_ptr<Node> Parser::primary() {
     
     // 4. Переменные и Вызовы функций
     if (tokens[pos].type == TokenType::IDENTIFIER) {
+        int line = tokens[pos].line;
         std::string name = consume(TokenType::IDENTIFIER).value;
         
         // Если дальше скобка '(', значит это ВЫЗОВ ФУНКЦИИ
@@ -55,7 +56,9 @@ std::unique_ptr<Node> Parser::primary() {
                 }
             }
             consume(TokenType::RPAREN);
-            return std::make_unique<FuncCallNode>(name, std::move(args));
+            auto call = std::make_unique<FuncCallNode>(name, std::move(args));
+            call->line = line; // строка нужна трассировке
+            return call;
         }
         // Иначе это просто доступ к переменной
         return std::make_unique<VarAccessNode>(name);
@@ -69,6 +72,41 @@ std::unique_ptr<Node> Parser::primary() {
         consume(TokenType::RPAREN); return std::make_unique<ArrayGetNode>(name, std::move(idx));
     }
     
+    if (tokens[pos].type == TokenType::PSUM) {
+        consume(TokenType::PSUM); consume(TokenType::LPAREN);
+        std::string name = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::RPAREN); return std::make_unique<ParallelSumNode>(name);
+    }
+
+    if (tokens[pos].type == TokenType::PREDUCE) {
+        int line = tokens[pos].line;
+        consume(TokenType::PREDUCE); consume(TokenType::LPAREN);
+        std::string name = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); std::string func = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); auto init = expression();
+        consume(TokenType::RPAREN);
+        auto reduce = std::make_unique<ParallelReduceNode>(name, func, std::move(init));
+        reduce->line = line;
+        return reduce;
+    }
+    
+    if (tokens[pos].type == TokenType::BSEARCH || tokens[pos].type == TokenType::INDEXOF) {
+        TokenType kind = tokens[pos].type; pos++;
+        consume(TokenType::LPAREN);
+        std::string name = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); auto value = expression();
+        consume(TokenType::RPAREN);
+        if (kind == TokenType::BSEARCH) return std::make_unique<BinarySearchNode>(name, std::move(value));
+        return std::make_unique<IndexOfNode>(name, std::move(value));
+    }
+
+    if (tokens[pos].type == TokenType::JOIN) {
+        consume(TokenType::JOIN); consume(TokenType::LPAREN);
+        std::string name = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); auto sep = expression();
+        consume(TokenType::RPAREN); return std::make_unique<JoinNode>(name, std::move(sep));
+    }
+
     if (tokens[pos].type == TokenType::INPUT) { 
         consume(TokenType::INPUT); consume(TokenType::LPAREN); consume(TokenType::RPAREN); 
         return std::make_unique<InputNode>(); 
@@ -117,13 +155,16 @@ std::unique_ptr<BlockNode> Parser::parseBlock() {
     consume(TokenType::LBRACE);
     auto block = std::make_unique<BlockNode>();
     while (tokens[pos].type != TokenType::RBRACE && tokens[pos].type != TokenType::END) {
+        int line = tokens[pos].line;
         block->stmts.push_back(statement());
+        if (!block->stmts.back()->line) block->stmts.back()->line = line;
     }
     consume(TokenType::RBRACE);
     return block;
 }
 
 void processInclude(std::string filename, Context& ctx, std::string currentFile) {
+    FOX_STAT_COUNT(includes, 1);
     std::string dir = getDirectory(currentFile);
     std::string fullPath = dir + filename; 
     std::ifstream file(fullPath);
@@ -144,8 +185,10 @@ void processInclude(std::string filename, Context& ctx, std::string currentFile)
 
     Parser parser(tokens);
     
-    // 1. Копируем текущую память внутрь include, чтобы он видел глобальные переменные
-    parser.globalContext = ctx; 
+    // 1. include работает прямо с текущей памятью: видит глобальные переменные,
+    // а его функции появятся в main. Без копирования туда-обратно задачи (spawn)
+    // и include всегда видят один и тот же Context.
+    parser.context = &ctx;
     parser.currentFile = fullPath; 
     
     // ВАЖНО: Мы убрали parser.importMode = true;
@@ -153,17 +196,16 @@ void processInclude(std::string filename, Context& ctx, std::string currentFile)
     parser.importMode = false; 
     
     parser.run(); 
-    
-    // 2. Возвращаем память обратно (функции из lib.fox появятся в main)
-    ctx = parser.globalContext; 
 }
 
 std::unique_ptr<Node> Parser::statement() {
     if (tokens[pos].type == TokenType::INCLUDE) {
+        int line = tokens[pos].line;
         consume(TokenType::INCLUDE); consume(TokenType::LPAREN);
         std::string file = consume(TokenType::STRING_LITERAL).value;
+        FOX_TRACE(Include, internName(file), line, 0);
         consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
-        processInclude(file, globalContext, currentFile);
+        processInclude(file, *context, currentFile);
         return std::make_unique<BlockNode>(); 
     }
 
@@ -192,13 +234,13 @@ std::unique_ptr<Node> Parser::statement() {
                 while(true) {
                     std::string pType = tokens[pos].value; pos++;
                     std::string pName = consume(TokenType::IDENTIFIER).value;
-                    params.push_back({pType, pName});
+                    params.push_back({pType, internName(pName)});
                     if (tokens[pos].type == TokenType::COMMA) consume(TokenType::COMMA); else break;
                 }
             }
             consume(TokenType::RPAREN);
             auto body = parseBlock();
-            globalContext.defineFunc(name, std::make_shared<FuncDefNode>(type, name, params, std::move(body)));
+            context->defineFunc(internName(name), std::make_shared<FuncDefNode>(type, name, params, std::move(body)));
             return std::make_unique<BlockNode>();
         }
 
@@ -219,11 +261,14 @@ std::unique_ptr<Node> Parser::statement() {
     }
 
     if (tokens[pos].type == TokenType::WHILE) {
+        int line = tokens[pos].line;
         consume(TokenType::WHILE); consume(TokenType::LPAREN);
         auto cond = comparison(); consume(TokenType::RPAREN);
         auto body = parseBlock();
         if (importMode) return std::make_unique<BlockNode>();
-        return std::make_unique<WhileNode>(std::move(cond), std::move(body));
+        auto loop = std::make_unique<WhileNode>(std::move(cond), std::move(body));
+        loop->line = line;
+        return loop;
     }
     
     if (tokens[pos].type == TokenType::IF) {
@@ -271,6 +316,68 @@ std::unique_ptr<Node> Parser::statement() {
         return std::make_unique<ArraySetNode>(name, std::move(idx), std::move(val));
     }
 
+    if (tokens[pos].type == TokenType::PMAP) {
+        int line = tokens[pos].line;
+        consume(TokenType::PMAP); consume(TokenType::LPAREN);
+        std::string dst = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); std::string src = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); std::string func = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
+        if (importMode) return std::make_unique<BlockNode>();
+        auto map = std::make_unique<ParallelMapNode>(dst, src, func);
+        map->line = line;
+        return map;
+    }
+
+    if (tokens[pos].type == TokenType::SORT || tokens[pos].type == TokenType::SORTSTR) {
+        bool numeric = tokens[pos].type == TokenType::SORT; pos++;
+        consume(TokenType::LPAREN);
+        std::string name = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
+        if (importMode) return std::make_unique<BlockNode>();
+        return std::make_unique<SortNode>(name, numeric);
+    }
+
+    if (tokens[pos].type == TokenType::SPLIT) {
+        consume(TokenType::SPLIT); consume(TokenType::LPAREN);
+        std::string dst = consume(TokenType::IDENTIFIER).value;
+        consume(TokenType::COMMA); auto str = expression();
+        consume(TokenType::COMMA); auto sep = expression();
+        consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
+        if (importMode) return std::make_unique<BlockNode>();
+        return std::make_unique<SplitNode>(dst, std::move(str), std::move(sep));
+    }
+
+    if (tokens[pos].type == TokenType::SPAWN) {
+        int line = tokens[pos].line;
+        consume(TokenType::SPAWN); consume(TokenType::LPAREN);
+        std::string name = consume(TokenType::IDENTIFIER).value;
+        std::vector<std::unique_ptr<Node>> args;
+        while (tokens[pos].type == TokenType::COMMA) {
+            consume(TokenType::COMMA);
+            args.push_back(expression());
+        }
+        consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
+        if (importMode) return std::make_unique<BlockNode>();
+        auto spawn = std::make_unique<SpawnNode>(name, std::move(args));
+        spawn->line = line;
+        return spawn;
+    }
+
+    if (tokens[pos].type == TokenType::YIELD) {
+        consume(TokenType::YIELD); consume(TokenType::LPAREN); consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
+        if (importMode) return std::make_unique<BlockNode>();
+        return std::make_unique<YieldNode>();
+    }
+
+    if (tokens[pos].type == TokenType::SLEEP) {
+        consume(TokenType::SLEEP); consume(TokenType::LPAREN);
+        auto ms = expression();
+        consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
+        if (importMode) return std::make_unique<BlockNode>();
+        return std::make_unique<SleepNode>(std::move(ms));
+    }
+
     if (tokens[pos].type == TokenType::IDENTIFIER) {
         if (tokens[pos+1].type == TokenType::ASSIGN) {
             std::string name = consume(TokenType::IDENTIFIER).value;
@@ -281,6 +388,7 @@ std::unique_ptr<Node> Parser::statement() {
             return std::make_unique<AssignNode>(name, std::move(expr));
         }
         if (tokens[pos+1].type == TokenType::LPAREN) {
+            int line = tokens[pos].line;
             std::string name = consume(TokenType::IDENTIFIER).value;
             consume(TokenType::LPAREN);
             std::vector<std::unique_ptr<Node>> args;
@@ -293,7 +401,9 @@ std::unique_ptr<Node> Parser::statement() {
             }
             consume(TokenType::RPAREN); consume(TokenType::SEMICOLON);
             if (importMode) return std::make_unique<BlockNode>();
-            return std::make_unique<FuncCallNode>(name, std::move(args));
+            auto call = std::make_unique<FuncCallNode>(name, std::move(args));
+            call->line = line;
+            return call;
         }
     }
 
@@ -302,6 +412,15 @@ std::unique_ptr<Node> Parser::statement() {
 
 void Parser::run() {
     while (tokens[pos].type != TokenType::END) {
-        statement()->eval(globalContext);
+        std::unique_ptr<Node> stmt;
+        int line = tokens[pos].line;
+        {
+            FOX_STAT_PHASE(Parser);
+            stmt = statement();
+        }
+        if (!stmt->line) stmt->line = line;
+        FOX_STAT_PHASE(Exec);
+        FOX_TRACE_LINE(stmt);
+        stmt->eval(*context);
     }
 }
\ No newline at end of file
@@ -11,6 +11,7 @@ class Parser {
     
 public:
     Context globalContext;
+    Context* context = &globalContext; // Память, с которой работает парсер (у include - память main)
     
     // НОВЫЕ ПОЛЯ ДЛЯ ПУТЕЙ И ИМПОРТА
     std::string currentFile; // Путь к файлу, который сейчас парсится
@@ -0,0 +1,157 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+// Статистика интерпретатора (флаг --stats).
+// Сборка с -DFOX_STATS=0 полностью убирает счетчики из кода,
+// иначе при выключенном флаге остается одна проверка bool на событие.
+#ifndef FOX_STATS
+#define FOX_STATS 1
+#endif
+
+enum class NodeKind {
+    FuncDef, Return, FuncCall, Number, String, VarAccess,
+    GlobalVarDecl, VarDecl, Assign, BinOp, Compare,
+    If, While, Block, Print, Input,
+    ArrayDecl, ArraySet, ArrayGet, Include, Fox,
+    ParallelMap, ParallelSum, ParallelReduce,
+    Spawn, Yield, Sleep,
+    Sort, BinarySearch, IndexOf, Split, Join,
+    COUNT
+};
+
+static const char* NODE_KIND_NAMES[] = {
+    "FuncDef", "Return", "FuncCall", "Number", "String", "VarAccess",
+    "GlobalVarDecl", "VarDecl", "Assign", "BinOp", "Compare",
+    "If", "While", "Block", "Print", "Input",
+    "ArrayDecl", "ArraySet", "ArrayGet", "Include", "Fox",
+    "ParallelMap", "ParallelSum", "ParallelReduce",
+    "Spawn", "Yield", "Sleep",
+    "Sort", "BinarySearch", "IndexOf", "Split", "Join"
+};
+
+// Фазы, между которыми делится время работы
+enum class Phase { None, Lexer, Parser, Exec, COUNT };
+
+struct Stats {
+    // Атомарные счетчики: pmap/preduce считают из нескольких потоков
+    using Counter = std::atomic<uint64_t>;
+
+    Counter nodes[(int)NodeKind::COUNT] = {};
+    Counter funcCalls{0};
+    Counter varLookups{0};
+    Counter lookupDepthTotal{0};
+    Counter lookupDepthMax{0};
+    Counter strings{0};
+    Counter stringBytes{0};
+    Counter arrayElements{0};
+    Counter includes{0};
+
+    // Время по фазам считается только в основном потоке
+    double phaseSeconds[(int)Phase::COUNT] = {};
+    Phase currentPhase = Phase::None;
+    std::chrono::steady_clock::time_point phaseStart = std::chrono::steady_clock::now();
+
+    static Stats& get() {
+        static Stats stats;
+        return stats;
+    }
+
+    void lookup(size_t depth) {
+        varLookups.fetch_add(1, std::memory_order_relaxed);
+        lookupDepthTotal.fetch_add(depth, std::memory_order_relaxed);
+        uint64_t prev = lookupDepthMax.load(std::memory_order_relaxed);
+        while (depth > prev && !lookupDepthMax.compare_exchange_weak(prev, depth, std::memory_order_relaxed)) {}
+    }
+
+    void addString(size_t bytes) {
+        strings.fetch_add(1, std::memory_order_relaxed);
+        stringBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // Переключает фазу, начисляя прошедшее время предыдущей
+    Phase switchPhase(Phase next) {
+        auto now = std::chrono::steady_clock::now();
+        phaseSeconds[(int)currentPhase] += std::chrono::duration<double>(now - phaseStart).count();
+        phaseStart = now;
+        Phase prev = currentPhase;
+        currentPhase = next;
+        return prev;
+    }
+
+    void print(std::ostream& out) {
+        switchPhase(Phase::None);
+        out << "\n=== FoxLang stats ===" << std::endl;
+        out << "Nodes evaluated:" << std::endl;
+        for (int i = 0; i < (int)NodeKind::COUNT; i++) {
+            uint64_t n = nodes[i].load();
+            if (n) out << "  " << std::left << std::setw(16) << NODE_KIND_NAMES[i] << n << std::endl;
+        }
+        uint64_t lookups = varLookups.load();
+        out << "Function calls:   " << funcCalls.load() << std::endl;
+        out << "Var lookups:      " << lookups;
+        if (lookups) {
+            out << " (avg depth " << std::fixed << std::setprecision(2)
+                << (double)lookupDepthTotal.load() / lookups
+                << ", max " << lookupDepthMax.load() << ")";
+        }
+        out << std::endl;
+        out << "Strings:          " << strings.load() << " (" << stringBytes.load() << " bytes)" << std::endl;
+        out << "Array elements:   " << arrayElements.load() << std::endl;
+        out << "Includes:         " << includes.load() << std::endl;
+        out << std::fixed << std::setprecision(3);
+        out << "Lexer time:       " << phaseSeconds[(int)Phase::Lexer] * 1000 << " ms" << std::endl;
+        out << "Parser time:      " << phaseSeconds[(int)Phase::Parser] * 1000 << " ms" << std::endl;
+        out << "Exec time:        " << phaseSeconds[(int)Phase::Exec] * 1000 << " ms" << std::endl;
+        out << "Peak RSS:         " << peakRssKb() << " KB" << std::endl;
+    }
+
+    static long peakRssKb() {
+#if defined(__unix__) || defined(__APPLE__)
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024; // на macOS в байтах
+#else
+        return usage.ru_maxrss;
+#endif
+#else
+        return 0;
+#endif
+    }
+};
+
+inline bool statsEnabled = false;
+
+// Фаза на время жизни объекта (вложенные фазы не считаются дважды)
+struct ScopedPhase {
+    Phase prev = Phase::None;
+    bool active;
+    ScopedPhase(Phase p) : active(statsEnabled) {
+        if (active) prev = Stats::get().switchPhase(p);
+    }
+    ~ScopedPhase() {
+        if (active) Stats::get().switchPhase(prev);
+    }
+};
+
+#if FOX_STATS
+#define FOX_STAT_NODE(kind) do { if (statsEnabled) Stats::get().nodes[(int)NodeKind::kind].fetch_add(1, std::memory_order_relaxed); } while (0)
+#define FOX_STAT_COUNT(counter, n) do { if (statsEnabled) Stats::get().counter.fetch_add((n), std::memory_order_relaxed); } while (0)
+#define FOX_STAT_LOOKUP(depth) do { if (statsEnabled) Stats::get().lookup(depth); } while (0)
+#define FOX_STAT_STRING(s) do { if (statsEnabled) Stats::get().addString((s).size()); } while (0)
+#define FOX_STAT_PHASE(p) ScopedPhase foxPhase_(Phase::p)
+#else
+#define FOX_STAT_NODE(kind) do {} while (0)
+#define FOX_STAT_COUNT(counter, n) do {} while (0)
+#define FOX_STAT_LOOKUP(depth) do {} while (0)
+#define FOX_STAT_STRING(s) do {} while (0)
+#define FOX_STAT_PHASE(p) do {} while (0)
+#endif
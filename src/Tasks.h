@@ -0,0 +1,331 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <string>
+#include "Parallel.h"
+#include "Trace.h"
+
+// Кооперативные задачи (spawn/yield/sleep) на одном потоке.
+// Вычислитель AST рекурсивный, поэтому задача - это собственный маленький
+// стек и переключение контекста (ucontext), а не поток ОС.
+// Там, где ucontext нет, spawn просто выполняет задачу сразу.
+#if defined(__unix__) || defined(__APPLE__)
+#define FOX_GREEN_THREADS 1
+#ifdef __APPLE__
+#define _XOPEN_SOURCE 600
+#endif
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <cerrno>
+#else
+#define FOX_GREEN_THREADS 0
+#endif
+
+// Стек одной задачи - как у основного потока, потому что вычислитель рекурсивный.
+// Память только резервируется и выделяется лениво, так что тысячи задач
+// занимают физически только то, что реально использовали.
+static const size_t TASK_STACK_SIZE = 8 * 1024 * 1024;
+
+// Запас стека, который должен оставаться свободным перед вызовом функции FoxLang:
+// на сам вызов с вложенными выражениями и на обработку ошибки.
+// Глубина рекурсии ограничена реальным размером стека, а не числом вызовов.
+static const size_t STACK_RESERVE = 256 * 1024;
+
+// Нижняя граница стека потока ОС (стек растет вниз) плюс запас.
+// 0 - границу узнать не удалось, проверки нет.
+inline uintptr_t threadStackLimit() {
+    void* addr = nullptr;
+    size_t size = 0;
+#if defined(__linux__)
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0) return 0;
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+#elif defined(__APPLE__)
+    size = pthread_get_stacksize_np(pthread_self());
+    addr = (char*)pthread_get_stackaddr_np(pthread_self()) - size;
+#endif
+    if (!addr || size <= STACK_RESERVE) return 0;
+    return (uintptr_t)addr + STACK_RESERVE;
+}
+
+// Граница для текущего потока. У задачи свой стек: планировщик подменяет
+// значение при переключении.
+inline uintptr_t& stackLimit() {
+    thread_local uintptr_t limit = threadStackLimit();
+    return limit;
+}
+
+// true, если стека осталось меньше STACK_RESERVE
+inline bool stackExhausted() {
+    char here;
+    return (uintptr_t)&here < stackLimit();
+}
+
+class Scheduler {
+    using Clock = std::chrono::steady_clock;
+
+    struct Task {
+        std::function<void()> body;
+        bool done = false;
+        bool waitingInput = false;
+        uint16_t traceThread = 0;
+        uint32_t traceLine = 0;
+        Clock::time_point wakeAt;
+#if FOX_GREEN_THREADS
+        ucontext_t ctx;
+        char* stack = nullptr;
+        size_t pageSize = 0;
+
+        ~Task() {
+            if (stack) munmap(stack - pageSize, TASK_STACK_SIZE + pageSize);
+        }
+#endif
+    };
+
+    std::vector<std::unique_ptr<Task>> tasks;
+    std::vector<uint16_t> freeTraceThreads;
+    Task* current = nullptr;
+    std::exception_ptr error;
+#if FOX_GREEN_THREADS
+    ucontext_t mainCtx;
+
+    static void entry() {
+        Scheduler& s = instance();
+        Task* t = s.current;
+        try { t->body(); }
+        catch (...) {
+            traceCurrentError(); // пока tid и строка - этой задачи
+            s.error = std::current_exception();
+        }
+        t->done = true;
+        // Возврат в mainCtx через uc_link
+    }
+#endif
+
+    // Собственный буфер stdin: задача, ждущая input, просыпается только когда
+    // в нем есть целая строка (или конец ввода), иначе чтение заблокировало бы всех.
+    // Мьютекс нужен для input внутри pmap/preduce.
+    std::string inputBuf;
+    bool inputEof = false;
+    std::mutex inputMtx;
+
+    bool lineBuffered() const {
+        return inputEof || inputBuf.find('\n') != std::string::npos;
+    }
+
+    // Забирает из stdin все, что уже пришло, не блокируясь
+    void fillInput() {
+#if FOX_GREEN_THREADS
+        char buf[4096];
+        while (!inputEof) {
+            struct pollfd pfd = {0, POLLIN, 0};
+            if (poll(&pfd, 1, 0) <= 0) return;
+            ssize_t n = read(0, buf, sizeof(buf));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { inputEof = true; return; }
+            inputBuf.append(buf, (size_t)n);
+        }
+#endif
+    }
+
+    bool inputReady() {
+        std::lock_guard<std::mutex> lock(inputMtx);
+        if (!lineBuffered()) fillInput();
+        return lineBuffered();
+    }
+
+    bool runnable(Task* t, Clock::time_point now) {
+        if (t->done) return false;
+        if (t->waitingInput) return inputReady();
+        return t->wakeAt <= now;
+    }
+
+    // Один проход по всем готовым задачам. Возвращает true, если кто-то работал.
+    bool runOnce() {
+#if FOX_GREEN_THREADS
+        bool ran = false;
+        size_t count = tasks.size(); // новые задачи пойдут со следующего прохода
+        for (size_t i = 0; i < count; i++) {
+            Task* t = tasks[i].get();
+            if (!runnable(t, Clock::now())) continue;
+            ran = true;
+            current = t;
+            uintptr_t mainLimit = stackLimit();
+            stackLimit() = (uintptr_t)t->stack + STACK_RESERVE;
+            uint16_t mainThread = 0;
+            uint32_t mainLine = 0;
+            if (traceEnabled) {
+                mainThread = Tracer::threadId();
+                mainLine = Tracer::currentLine();
+                Tracer::threadId() = t->traceThread;
+                Tracer::currentLine() = t->traceLine;
+            }
+            swapcontext(&mainCtx, &t->ctx);
+            stackLimit() = mainLimit;
+            if (traceEnabled) {
+                t->traceLine = Tracer::currentLine();
+                Tracer::threadId() = mainThread;
+                Tracer::currentLine() = mainLine;
+            }
+            current = nullptr;
+            if (error) {
+                std::exception_ptr e = error;
+                error = nullptr;
+                std::rethrow_exception(e);
+            }
+        }
+        // tid завершенных задач достаются новым: дорожки в трассе не кончаются
+        for (auto& t : tasks) {
+            if (t->done && traceEnabled) freeTraceThreads.push_back(t->traceThread);
+        }
+        tasks.erase(std::remove_if(tasks.begin(), tasks.end(),
+            [](const std::unique_ptr<Task>& t) { return t->done; }), tasks.end());
+        return ran;
+#else
+        return false;
+#endif
+    }
+
+    // Никто не готов: ждем ввода или ближайшего таймера, не крутя процессор
+    void idle(Clock::time_point until, bool wantInput) {
+#if FOX_GREEN_THREADS
+        Clock::time_point wake = until;
+        for (auto& t : tasks) {
+            if (t->waitingInput) wantInput = true;
+            else if (!t->done) wake = std::min(wake, t->wakeAt);
+        }
+        if (wake == Clock::time_point::max() && !wantInput) return;
+        auto now = Clock::now();
+        long ms = wake <= now ? 0 : (long)std::chrono::ceil<std::chrono::milliseconds>(wake - now).count();
+        if (wantInput) {
+            struct pollfd pfd = {0, POLLIN, 0};
+            poll(&pfd, 1, wake == Clock::time_point::max() ? -1 : (int)std::min(ms, 60000L));
+        } else if (ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        }
+#endif
+    }
+
+    // Внутри pmap/preduce переключаться нельзя: задачи живут в основном потоке
+    bool canSwitch() const {
+        return FOX_GREEN_THREADS && !ThreadPool::insideWorker();
+    }
+
+public:
+    static Scheduler& instance() {
+        static Scheduler scheduler;
+        return scheduler;
+    }
+
+    size_t taskCount() const { return tasks.size(); }
+
+    void spawn(std::function<void()> body) {
+        if (!canSwitch()) { body(); return; }
+#if FOX_GREEN_THREADS
+        auto t = std::make_unique<Task>();
+        t->body = std::move(body);
+        t->wakeAt = Clock::now();
+        if (traceEnabled) {
+            if (freeTraceThreads.empty()) t->traceThread = Tracer::get().newThreadId();
+            else { t->traceThread = freeTraceThreads.back(); freeTraceThreads.pop_back(); }
+        }
+
+        // Стек с защитной страницей снизу: переполнение - сразу SIGSEGV, а не порча памяти
+        t->pageSize = (size_t)sysconf(_SC_PAGESIZE);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+        flags |= MAP_NORESERVE; // не резервировать swap под весь стек
+#endif
+        void* mem = mmap(nullptr, TASK_STACK_SIZE + t->pageSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (mem == MAP_FAILED) throw std::runtime_error("Runtime Error: Cannot allocate task stack");
+        mprotect(mem, t->pageSize, PROT_NONE);
+        t->stack = (char*)mem + t->pageSize;
+
+        getcontext(&t->ctx);
+        t->ctx.uc_stack.ss_sp = t->stack;
+        t->ctx.uc_stack.ss_size = TASK_STACK_SIZE;
+        t->ctx.uc_link = &mainCtx;
+        makecontext(&t->ctx, entry, 0);
+        tasks.push_back(std::move(t));
+#endif
+    }
+
+    // В задаче - вернуть управление планировщику.
+    // В основной программе - дать поработать всем готовым задачам.
+    void yield() {
+        if (!canSwitch()) return;
+#if FOX_GREEN_THREADS
+        if (current) swapcontext(&current->ctx, &mainCtx);
+        else runOnce();
+#endif
+    }
+
+    void sleepFor(double ms) {
+        auto until = Clock::now() + std::chrono::microseconds((long long)(ms * 1000));
+        if (!canSwitch()) { std::this_thread::sleep_until(until); return; }
+        if (current) {
+            current->wakeAt = until;
+            yield();
+            return;
+        }
+        while (Clock::now() < until) {
+            if (!runOnce()) idle(until, false);
+        }
+    }
+
+    // Ждет, пока в stdin появится строка, не блокируя остальные задачи
+    void waitInput() {
+        if (!canSwitch()) return;
+        if (current) {
+            current->waitingInput = true;
+            while (!inputReady()) yield();
+            current->waitingInput = false;
+            return;
+        }
+        while (!tasks.empty() && !inputReady()) {
+            if (!runOnce()) idle(Clock::time_point::max(), true);
+        }
+    }
+
+    // Строка из stdin без '\n' (в конце ввода - пустая).
+    // Пока строка не пришла целиком, работают другие задачи.
+    std::string readLine() {
+#if FOX_GREEN_THREADS
+        waitInput();
+        std::lock_guard<std::mutex> lock(inputMtx);
+        // Задач нет или мы внутри pmap/preduce: просто ждем
+        while (!lineBuffered()) {
+            struct pollfd pfd = {0, POLLIN, 0};
+            poll(&pfd, 1, -1);
+            fillInput();
+        }
+        size_t end = inputBuf.find('\n');
+        std::string line = inputBuf.substr(0, end);
+        inputBuf.erase(0, end == std::string::npos ? end : end + 1);
+        return line;
+#else
+        std::string line;
+        std::getline(std::cin, line);
+        return line;
+#endif
+    }
+
+    // Выполняет задачи, пока все не закончатся (вызывается в конце программы)
+    void runAll() {
+        while (!tasks.empty()) {
+            if (!runOnce()) idle(Clock::time_point::max(), false);
+        }
+    }
+};
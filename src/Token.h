@@ -17,6 +17,15 @@ enum class TokenType {
     
     // НОВЫЕ: возврат и глобальные
     RETURN, GLOBAL,
+
+    // Параллельные операции над массивами
+    PMAP, PSUM, PREDUCE,
+
+    // Задачи
+    SPAWN, YIELD, SLEEP,
+
+    // Сортировка, поиск, строки
+    SORT, SORTSTR, BSEARCH, INDEXOF, SPLIT, JOIN,
     
     IDENTIFIER, 
     END, ERROR
@@ -0,0 +1,330 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <csignal>
+#include <string>
+#include <algorithm>
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <x86intrin.h>
+#define FOX_TRACE_RDTSC 1
+#else
+#define FOX_TRACE_RDTSC 0
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#define FOX_TRACE_POSIX 1
+#else
+#include <cstdio>
+#define FOX_TRACE_POSIX 0
+#endif
+
+// Трассировка выполнения (флаг --trace).
+// У каждого потока ОС свой кольцевой буфер, в который пишет только он сам:
+// запись события не трогает общих счетчиков и чужих кэш-линий,
+// старые события затираются новыми. Буферы сливаются по времени при сбросе
+// в файл (при выходе, ошибке или сигнале) в формате Chrome Trace Event
+// (открывается в chrome://tracing и ui.perfetto.dev).
+
+enum class TraceEvent : uint8_t { FuncEnter, FuncExit, Include, Loop, Error };
+
+struct TraceRecord {
+    uint64_t ticks;           // rdtsc или steady_clock, в наносекунды переводится при сбросе
+    const std::string* name;  // интернированное имя: функция или файл
+    uint64_t value;           // Loop: число итераций
+    uint32_t line;
+    uint16_t thread;
+    TraceEvent type;
+};
+
+// Размер буфера потока (степень двойки): 32K событий по 32 байта = 1 МБ
+static const size_t TRACE_CAPACITY = 1 << 15;
+// Сколько потоков могут писать события; события остальных теряются
+static const size_t TRACE_MAX_RINGS = 256;
+// Цикл пишет событие раз в столько итераций и при выходе
+static const uint64_t TRACE_LOOP_SAMPLE = 4096;
+
+// Буфер одного потока ОС (задачи spawn пишут в буфер основного потока)
+struct alignas(64) TraceRing {
+    TraceRecord records[TRACE_CAPACITY];
+    std::atomic<uint64_t> head{0}; // меняет только владелец, читает сброс
+};
+
+struct Tracer {
+    std::atomic<TraceRing*> rings[TRACE_MAX_RINGS] = {};
+    std::atomic<size_t> ringCount{0};
+    std::atomic<uint16_t> nextThread{0};
+    std::atomic<bool> dumping{false};
+    std::atomic<bool> errorRecorded{false};
+    char path[512] = "foxlang.trace.json";
+    char errorText[256] = "";
+
+    // Калибровка тиков: две точки (тики, наносекунды steady_clock)
+    uint64_t startTicks = 0;
+    int64_t startNs = 0;
+
+    static Tracer& get() {
+        static Tracer* tracer = new Tracer(); // живет до конца, доступен из обработчика сигнала
+        return *tracer;
+    }
+
+    static uint64_t ticks() {
+#if FOX_TRACE_RDTSC
+        return __rdtsc();
+#else
+        return (uint64_t)nowNs();
+#endif
+    }
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // tid события: свой у каждого потока ОС и у каждой задачи spawn.
+    // Задачи делят один поток, поэтому планировщик подменяет значение
+    // при переключении, иначе их B/E перемешаются на одной дорожке.
+    static uint16_t& threadId() {
+        thread_local uint16_t id = get().newThreadId();
+        return id;
+    }
+
+    uint16_t newThreadId() { return nextThread.fetch_add(1); }
+
+    // Строка последнего выполненного оператора в этом потоке (или задаче):
+    // ее получает событие Error
+    static uint32_t& currentLine() {
+        thread_local uint32_t line = 0;
+        return line;
+    }
+
+    void start(const std::string& outPath) {
+        if (!outPath.empty()) {
+            std::strncpy(path, outPath.c_str(), sizeof(path) - 1);
+        }
+        startTicks = ticks();
+        startNs = nowNs();
+        threadId(); // основной поток получает tid 0 раньше любой задачи
+    }
+
+    // Буфер текущего потока, создается при его первом событии
+    static TraceRing* ring() {
+        thread_local TraceRing* r = get().newRing();
+        return r;
+    }
+
+    TraceRing* newRing() {
+        size_t i = ringCount.fetch_add(1);
+        if (i >= TRACE_MAX_RINGS) return nullptr;
+        TraceRing* r = new TraceRing();
+        rings[i].store(r, std::memory_order_release);
+        return r;
+    }
+
+    void record(TraceEvent type, const std::string* name, uint32_t line, uint64_t value = 0) {
+        TraceRing* ring = Tracer::ring();
+        if (!ring) return;
+        uint64_t slot = ring->head.load(std::memory_order_relaxed);
+        TraceRecord& r = ring->records[slot & (TRACE_CAPACITY - 1)];
+        r.ticks = ticks();
+        r.name = name;
+        r.value = value;
+        r.line = line;
+        r.thread = threadId();
+        r.type = type;
+        ring->head.store(slot + 1, std::memory_order_release);
+    }
+
+    // Пишется только первая ошибка: там, где она возникла (в задаче или потоке pmap),
+    // а не там, куда она потом дошла
+    void error(const char* text) {
+        if (errorRecorded.exchange(true)) return;
+        std::strncpy(errorText, text, sizeof(errorText) - 1);
+        record(TraceEvent::Error, nullptr, currentLine());
+    }
+
+    // Сброс в файл. Без выделения памяти и iostream, чтобы работать из обработчика сигнала.
+    void dump() {
+        if (dumping.exchange(true)) return;
+        // Второй точкой калибровки служит момент сброса
+        uint64_t endTicks = ticks();
+        int64_t endNs = nowNs();
+        double nsPerTick = (endTicks > startTicks) ? (double)(endNs - startNs) / (double)(endTicks - startTicks) : 1.0;
+
+        Writer w(path);
+        if (!w.ok()) { dumping = false; return; }
+        w.put("{\"traceEvents\":[\n");
+
+        // Слияние буферов: каждый раз берется самое раннее из непрочитанных событий
+        TraceRing* rs[TRACE_MAX_RINGS];
+        uint64_t pos[TRACE_MAX_RINGS], end[TRACE_MAX_RINGS];
+        size_t count = 0;
+        uint64_t dropped = 0;
+        size_t total = std::min(ringCount.load(), TRACE_MAX_RINGS);
+        for (size_t i = 0; i < total; i++) {
+            TraceRing* ring = rings[i].load(std::memory_order_acquire);
+            if (!ring) continue;
+            rs[count] = ring;
+            end[count] = ring->head.load(std::memory_order_acquire);
+            pos[count] = end[count] > TRACE_CAPACITY ? end[count] - TRACE_CAPACITY : 0;
+            dropped += pos[count];
+            count++;
+        }
+
+        bool first = true;
+        while (true) {
+            size_t next = count;
+            for (size_t i = 0; i < count; i++) {
+                if (pos[i] == end[i]) continue;
+                if (next == count || rs[i]->records[pos[i] & (TRACE_CAPACITY - 1)].ticks <
+                                     rs[next]->records[pos[next] & (TRACE_CAPACITY - 1)].ticks) next = i;
+            }
+            if (next == count) break;
+            const TraceRecord& r = rs[next]->records[pos[next]++ & (TRACE_CAPACITY - 1)];
+            double us = (double)(int64_t)(r.ticks - startTicks) * nsPerTick / 1000.0;
+            if (!first) w.put(",\n");
+            first = false;
+            w.put("{\"pid\":1,\"tid\":"); w.num(r.thread);
+            w.put(",\"ts\":"); w.num((int64_t)us); w.put("."); w.num((int64_t)(us * 1000) % 1000, 3);
+            switch (r.type) {
+                case TraceEvent::FuncEnter: w.put(",\"ph\":\"B\",\"cat\":\"func\",\"name\":"); w.str(r.name); break;
+                case TraceEvent::FuncExit:  w.put(",\"ph\":\"E\",\"cat\":\"func\",\"name\":"); w.str(r.name); break;
+                case TraceEvent::Include:   w.put(",\"ph\":\"i\",\"s\":\"g\",\"cat\":\"include\",\"name\":"); w.str(r.name); break;
+                case TraceEvent::Loop:      w.put(",\"ph\":\"i\",\"s\":\"t\",\"cat\":\"loop\",\"name\":\"while\""); break;
+                case TraceEvent::Error:     w.put(",\"ph\":\"i\",\"s\":\"g\",\"cat\":\"error\",\"name\":\"error\""); break;
+            }
+            w.put(",\"args\":{\"line\":"); w.num(r.line);
+            if (r.type == TraceEvent::Loop) { w.put(",\"iterations\":"); w.num((int64_t)r.value); }
+            if (r.type == TraceEvent::Error) { w.put(",\"message\":"); w.str(errorText); }
+            w.put("}}");
+        }
+        w.put("\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":");
+        w.num((int64_t)dropped);
+        w.put("}}\n");
+        dumping = false;
+    }
+
+private:
+    // Минимальный буферизованный вывод поверх write(2)
+    struct Writer {
+        char buf[4096];
+        size_t len = 0;
+#if FOX_TRACE_POSIX
+        int fd;
+        Writer(const char* p) : fd(open(p, O_WRONLY | O_CREAT | O_TRUNC, 0644)) {}
+        ~Writer() { flush(); if (fd >= 0) close(fd); }
+        bool ok() const { return fd >= 0; }
+        void flush() { if (fd >= 0 && len) { ssize_t n = write(fd, buf, len); (void)n; } len = 0; }
+#else
+        std::FILE* f;
+        Writer(const char* p) : f(std::fopen(p, "w")) {}
+        ~Writer() { flush(); if (f) std::fclose(f); }
+        bool ok() const { return f != nullptr; }
+        void flush() { if (f && len) std::fwrite(buf, 1, len, f); len = 0; }
+#endif
+        void putc(char c) { if (len == sizeof(buf)) flush(); buf[len++] = c; }
+        void put(const char* s) { while (*s) putc(*s++); }
+        void num(int64_t v, int width = 0) {
+            char tmp[24]; int n = 0;
+            bool neg = v < 0; if (neg) v = -v;
+            do { tmp[n++] = (char)('0' + v % 10); v /= 10; } while (v);
+            while (n < width) tmp[n++] = '0';
+            if (neg) putc('-');
+            while (n) putc(tmp[--n]);
+        }
+        void str(const char* s) {
+            putc('"');
+            for (; s && *s; s++) {
+                if (*s == '"' || *s == '\\') putc('\\');
+                if ((unsigned char)*s >= 0x20) putc(*s);
+            }
+            putc('"');
+        }
+        void str(const std::string* s) { str(s ? s->c_str() : "?"); }
+    };
+};
+
+inline bool traceEnabled = false;
+
+// Сброс по сигналу: SIGUSR1 - сбросить и продолжить, остальные - сбросить и завершиться
+inline void traceSignalHandler(int sig) {
+    Tracer::get().dump();
+#ifdef SIGUSR1
+    if (sig == SIGUSR1) return;
+#endif
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+#if FOX_TRACE_POSIX
+// Отдельный стек для обработчика: при переполнении стека задачи
+// (или основного потока) на текущем стеке места уже нет
+static const size_t TRACE_SIGNAL_STACK = 64 * 1024;
+
+inline void traceInstallSignal(int sig) {
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = traceSignalHandler;
+    sa.sa_flags = SA_ONSTACK;
+    sigemptyset(&sa.sa_mask);
+    sigaction(sig, &sa, nullptr);
+}
+
+inline void traceInstallSignals() {
+    static char altStack[TRACE_SIGNAL_STACK];
+    stack_t ss;
+    std::memset(&ss, 0, sizeof(ss));
+    ss.ss_sp = altStack;
+    ss.ss_size = sizeof(altStack);
+    sigaltstack(&ss, nullptr);
+
+    traceInstallSignal(SIGINT);
+    traceInstallSignal(SIGTERM);
+    traceInstallSignal(SIGSEGV);
+    traceInstallSignal(SIGBUS);
+    traceInstallSignal(SIGABRT);
+    traceInstallSignal(SIGUSR1);
+}
+#else
+inline void traceInstallSignals() {
+    std::signal(SIGINT, traceSignalHandler);
+    std::signal(SIGTERM, traceSignalHandler);
+    std::signal(SIGSEGV, traceSignalHandler);
+    std::signal(SIGABRT, traceSignalHandler);
+}
+#endif
+
+// Вход/выход функции: выход пишется и при исключении.
+// При обычном возврате текущая строка снова указывает на вызов,
+// при исключении остается строка, где оно возникло.
+struct TraceFuncScope {
+    const std::string* name;
+    uint32_t line;
+    int exceptions = 0;
+    TraceFuncScope(const std::string* n, int l) : name(n), line((uint32_t)l) {
+        if (!traceEnabled) return;
+        exceptions = std::uncaught_exceptions();
+        Tracer::get().record(TraceEvent::FuncEnter, name, line);
+    }
+    ~TraceFuncScope() {
+        if (!traceEnabled) return;
+        Tracer::get().record(TraceEvent::FuncExit, name, line);
+        if (std::uncaught_exceptions() == exceptions) Tracer::currentLine() = line;
+    }
+};
+
+#define FOX_TRACE_LINE(node) do { if (traceEnabled) Tracer::currentLine() = (uint32_t)(node)->line; } while (0)
+
+// Вызывается внутри catch: записывает текущее исключение с tid и строкой этого потока
+inline void traceCurrentError() {
+    if (!traceEnabled) return;
+    try { throw; }
+    catch (const std::exception& e) { Tracer::get().error(e.what()); }
+    catch (...) { Tracer::get().error("unknown error"); }
+}
+
+#define FOX_TRACE(type, name, line, value) do { if (traceEnabled) Tracer::get().record(TraceEvent::type, (name), (uint32_t)(line), (value)); } while (0)
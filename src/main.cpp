@@ -3,17 +3,43 @@
 #include <sstream>
 #include "Lexer.h"
 #include "Parser.h"
+#include "Stats.h"
+#include "Tasks.h"
+#include "Trace.h"
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Usage: foxlang <script.fox>" << std::endl;
+    // Разбираем флаги: foxlang [--stats] [--trace[=file]] <script.fox>
+    std::string scriptPath;
+    std::string tracePath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+#if FOX_STATS
+            statsEnabled = true;
+#else
+            std::cerr << "Error: --stats is not available, interpreter was built with FOX_STATS=0" << std::endl;
+            return 1;
+#endif
+        }
+        else if (arg == "--trace") traceEnabled = true;
+        else if (arg.rfind("--trace=", 0) == 0) { traceEnabled = true; tracePath = arg.substr(8); }
+        else scriptPath = arg;
+    }
+
+    if (scriptPath.empty()) {
+        std::cout << "Usage: foxlang [--stats] [--trace[=file]] <script.fox>" << std::endl;
         return 1;
     }
 
+    if (traceEnabled) {
+        Tracer::get().start(tracePath);
+        traceInstallSignals();
+    }
+
     // 1. Читаем файл
-    std::ifstream file(argv[1]);
+    std::ifstream file(scriptPath);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << argv[1] << std::endl;
+        std::cerr << "Error: Could not open file " << scriptPath << std::endl;
         return 1;
     }
 
@@ -21,16 +47,33 @@ int main(int argc, char* argv[]) {
     buffer << file.rdbuf();
     std::string code = buffer.str();
 
-    // 2. Запускаем конвейер
-    Lexer lexer(code);
-    std::vector<Token> tokens = lexer.tokenize();
+    try {
+        // 2. Запускаем конвейер
+        Lexer lexer(code);
+        std::vector<Token> tokens = lexer.tokenize();
 
-    Parser parser(tokens);
-    
-    // ВАЖНО: Передаем имя файла, чтобы парсер знал, где он находится
-    parser.currentFile = argv[1]; 
+        Parser parser(tokens);
+
+        // ВАЖНО: Передаем имя файла, чтобы парсер знал, где он находится
+        parser.currentFile = scriptPath;
+
+        parser.run();
+
+        // Дожидаемся задач, запущенных через spawn
+        FOX_STAT_PHASE(Exec);
+        Scheduler::instance().runAll();
+    } catch (...) {
+        // Статистика и трасса нужны и когда скрипт упал
+        if (traceEnabled) {
+            traceCurrentError();
+            Tracer::get().dump();
+        }
+        if (statsEnabled) Stats::get().print(std::cerr);
+        throw;
+    }
 
-    parser.run();
+    if (traceEnabled) Tracer::get().dump();
+    if (statsEnabled) Stats::get().print(std::cerr);
 
     return 0;
-}
\ No newline at end of file
+}